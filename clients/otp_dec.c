@@ -16,6 +16,7 @@
 #include <netinet/in.h>
 #include <netdb.h> 
 #include <sys/ioctl.h>
+#include "../daemons/padcache.h"
 
 void error(const char *msg) { perror(msg); exit(0); } // Error function used for reporting issues
 
@@ -115,22 +116,57 @@ int main(int argc, char *argv[])
 	/* ensure that key is long enought to decode cipher */
 	if (strlen(buffer) < ciphertextlen) { perror("CLIENT: key too short to decode ciphertext"); exit(1); }	
 
-	//printf("CLIENT: sending this key to the server: %s\n", buffer); fflush(stdout);
-
-	charsWritten = send(socketFD, buffer, strlen(buffer), 0);
+	/* offer the key by hash first. The daemon replies hit@@ if it already holds the decoded pad */
+	int keylen = strlen(buffer) - 2;
+	char reply[64];
+	int replylen = 0;
+	unsigned char digest[PADCACHE_DIGEST_LEN];
+	char hex[PADCACHE_HEX_LEN + 1];
+	padcache_hash(buffer, keylen, digest);
+	padcache_hexdigest(digest, hex);
+	memset(tempbuffer, '\0', sizeof(tempbuffer));
+	sprintf(tempbuffer, "pad %s %d@@", hex, keylen);
+	charsWritten = send(socketFD, tempbuffer, strlen(tempbuffer), 0);
 	if (charsWritten < 0) error("CLIENT: ERROR writing to socket");
-	if (charsWritten < strlen(buffer)) printf("CLIENT: WARNING: Not all data written to socket!\n");
-	checkSend = -5;
-	do {
-		ioctl(socketFD, TIOCOUTQ, &checkSend);
-	} while (checkSend > 0);
+	memset(reply, '\0', sizeof(reply));
+	ret = 0;
+	while (!ret || (strstr(reply, "@@") == NULL)) {
+		ret = select(socketFD + 1, &readFDs, NULL, NULL, &idle);
+		if (ret) {
+			memset(tempbuffer, '\0', sizeof(tempbuffer));
+			charsRead = recv(socketFD, tempbuffer, sizeof(tempbuffer) - 1, 0);
+			if (charsRead <= 0) error("CLIENT: ERROR reading from socket");
+			/* skip the \0 padding left over from the handshake reply. On a hit the response can arrive in
+			 * the same read as hit@@, so whatever follows @@ is kept at the front of tempbuffer */
+			int i = 0;
+			for (; i < charsRead && strstr(reply, "@@") == NULL; i++) {
+				if (tempbuffer[i] != '\0' && replylen < sizeof(reply) - 1) { reply[replylen++] = tempbuffer[i]; }
+			}
+			memmove(tempbuffer, tempbuffer + i, charsRead - i);
+			memset(tempbuffer + charsRead - i, '\0', i);
+		}
+	}
+
+	if (strstr(reply, "abort")) { fprintf(stderr, "CLIENT: server rejected the key\n"); exit(1); }
+	if (strstr(reply, "miss") != NULL) {		// upload the key only when the daemon does not have it
+		//printf("CLIENT: sending this key to the server: %s\n", buffer); fflush(stdout);
+
+		charsWritten = send(socketFD, buffer, strlen(buffer), 0);
+		if (charsWritten < 0) error("CLIENT: ERROR writing to socket");
+		if (charsWritten < strlen(buffer)) printf("CLIENT: WARNING: Not all data written to socket!\n");
+		checkSend = -5;
+		do {
+			ioctl(socketFD, TIOCOUTQ, &checkSend);
+		} while (checkSend > 0);
+	}
 
 	fclose(keyfile);
 
 	// Get return message from server
 	memset(buffer, '\0', sizeof(buffer)); // Clear out the buffer again for reuse
+	strcpy(buffer, tempbuffer);		// start from any part of the response read with the reply
 	memset(tempbuffer, '\0', sizeof(tempbuffer));  
-	ret = 0;
+	ret = (strstr(buffer, "@@") != NULL);
 	while (!ret || (strstr(buffer, "@@") == NULL)) {
 		//printf("CLIENT: waiting for server response\n"); fflush(stdout);
 		ret = select(socketFD + 1, &readFDs, NULL, NULL, &idle);
@@ -143,6 +179,7 @@ int main(int argc, char *argv[])
 			memset(tempbuffer, '\0', sizeof(tempbuffer));
 		}
 	}
+	if (strstr(buffer, "abort")) { fprintf(stderr, "CLIENT: server rejected the key\n"); exit(1); }
 	buffer[strcspn(buffer, "@@")] = '\0';
 
 	//printf("CLIENT: response from the server: %s", buffer);
@@ -6,6 +6,8 @@
  *			Berkeley Sockets API. Accepts a cipher text and key and returns the corresponding plaintext. 
  * ************************************************************************************************************************/
 
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,22 +19,54 @@
 #include <netdb.h>
 #include <sys/ioctl.h>
 #include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#include "padcache.h"
+#include "otpkernel.h"
 
 void error(const char *msg) { perror(msg); exit(1); } // Error function used for reporting issues
 
+struct padcache* cache = NULL;	// decoded pads shared with every forked child
+void reportCache(int sig) { padcache_report(cache, STDERR_FILENO); } // SIGUSR1 prints cache counters
+volatile sig_atomic_t stopRequested = 0;
+void stopServer(int sig) { stopRequested = 1; } // SIGTERM asks the main loop to exit, so profile output is written
+
+/* tell the client to give up and end this request */
+void rejectRequest(int connectionFD, const char* why) {
+	fprintf(stderr, "SERVER: %s\n", why);
+	send(connectionFD, "abort@@", 7, 0);
+	exit(1);
+}
+
 int main(int argc, char *argv[])
 {
 	int listenSocketFD, establishedConnectionFD, portNumber, charsRead, handShakeLength = 12;
 	socklen_t sizeOfClientInfo;
-	char* charoptions = " ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 	char buffer[262144];
 	char tempbuffer[262144];
 	char ciphertext[262144];
 	char key[262144];
+	unsigned char pad[262144];
 	char plaintext[262144];
 	struct sockaddr_in serverAddress, clientAddress;
 
-	if (argc < 2) { fprintf(stderr,"USAGE: %s port\n", argv[0]); exit(1); } // Check usage & args
+	if (argc < 2) { fprintf(stderr,"USAGE: %s port [cache_kib]\n", argv[0]); exit(1); } // Check usage & args
+
+	/* map the pad cache before forking so children share it. A cap of 0 disables caching */
+	long cacheKiB = (argc > 2) ? atol(argv[2]) : PADCACHE_DEFAULT_KIB;
+	if (cacheKiB < 0) cacheKiB = 0;
+	cache = padcache_create((size_t)cacheKiB * 1024);
+	otpkernel_init();	// build the lookup tables once, before forking
+	struct sigaction reportAction;
+	memset(&reportAction, 0, sizeof(reportAction));
+	reportAction.sa_handler = reportCache;
+	reportAction.sa_flags = SA_RESTART;		// keep accept() blocking across SIGUSR1
+	sigaction(SIGUSR1, &reportAction, NULL);
+	struct sigaction stopAction;
+	memset(&stopAction, 0, sizeof(stopAction));
+	stopAction.sa_handler = stopServer;
+	stopAction.sa_flags = 0;			// no SA_RESTART, so accept() and waitpid() return EINTR
+	sigaction(SIGTERM, &stopAction, NULL);
 
 	// Set up the address struct for this process (the server)
 	memset((char *)&serverAddress, '\0', sizeof(serverAddress)); // Clear out the address struct
@@ -44,6 +78,8 @@ int main(int argc, char *argv[])
 	// Set up the socket
 	listenSocketFD = socket(AF_INET, SOCK_STREAM, 0); // Create the socket
 	if (listenSocketFD < 0) error("ERROR opening socket");
+	int reuse = 1;		// rebind straight away after a restart, even with connections still in TIME_WAIT
+	setsockopt(listenSocketFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
 
 	// Enable the socket to begin listening
 	if (bind(listenSocketFD, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0) // Connect socket to port
@@ -51,10 +87,11 @@ int main(int argc, char *argv[])
 	listen(listenSocketFD, 5); // Flip the socket on - it can now receive up to 5 connections
 
 	/* infinite loop accepts client connections */
-	while (1) {
+	while (!stopRequested) {
 		// Accept a connection, blocking if one is not available until one connects
 		sizeOfClientInfo = sizeof(clientAddress); // Get the size of the address for the client that will connect
 		establishedConnectionFD = accept(listenSocketFD, (struct sockaddr *)&clientAddress, &sizeOfClientInfo); // Accept
+		if (stopRequested) exit(0);		// SIGTERM interrupted accept()
 		if (establishedConnectionFD < 0) error("ERROR on accept");
 
 		/* set up fd_set for calls to select() */
@@ -79,9 +116,13 @@ int main(int argc, char *argv[])
 			ret = 0;
 			while (!ret && (strstr(buffer, "@@") == NULL)) {			// listen for input, ending in @@
 				ret = select(establishedConnectionFD + 1, &readFDs, NULL, NULL, &idle);
+				if (ret == 0 || stopRequested) exit(1);	// idle timeout, or SIGTERM interrupted select(): drop the client
 				if (ret) {
 					charsRead = recv(establishedConnectionFD, tempbuffer, handShakeLength, 0);
 					if (charsRead < 0) error("ERROR reading from socket");
+					if (charsRead == 0) exit(1);	// client hung up before finishing the message
+					/* leave room for the terminator, anything longer than buffer cannot be a valid message */
+					if (strlen(buffer) + charsRead >= sizeof(buffer)) rejectRequest(establishedConnectionFD, "message too long");
 					strcat(buffer, tempbuffer);
 					memset(tempbuffer, '\0', sizeof(tempbuffer));
 				}
@@ -106,9 +147,12 @@ int main(int argc, char *argv[])
 			ret = 0;
 			while (!ret || (strstr(buffer, "@@") == NULL)) {			// accept input, ending in @@
 				ret = select(establishedConnectionFD + 1, &readFDs, NULL, NULL, &idle);
+				if (ret == 0 || stopRequested) exit(1);	// idle timeout, or SIGTERM interrupted select(): drop the client
 				if (ret) {
-					charsRead = recv(establishedConnectionFD, tempbuffer, sizeof(tempbuffer), 0); // Read the client's message from the socket
+					charsRead = recv(establishedConnectionFD, tempbuffer, sizeof(tempbuffer) - 1, 0); // Read the client's message from the socket
 					if (charsRead < 0) error("ERROR reading from socket");
+					if (charsRead == 0) exit(1);	// client hung up before finishing the message
+					if (strlen(buffer) + charsRead >= sizeof(buffer)) rejectRequest(establishedConnectionFD, "message too long");
 					strcat(buffer, tempbuffer);
 					memset(tempbuffer, '\0', sizeof(tempbuffer));
 				}
@@ -118,45 +162,74 @@ int main(int argc, char *argv[])
 			strcpy(ciphertext, buffer);
 			ciphertext[strcspn(ciphertext, "@@")] = '\0';
 
-			// Get the key from the client
-			charsRead = sizeof(buffer);
-			memset(buffer, '\0', sizeof(tempbuffer));
-			ret = 0;
+			// Get the pad hash from the client and check whether the decoded pad is already cached
+			/* the hash can arrive in the same recv() as the previous message, so carry over anything after @@ */
+			memset(tempbuffer, '\0', sizeof(tempbuffer));
+			strcpy(tempbuffer, strstr(buffer, "@@") + 2);
+			memset(buffer, '\0', sizeof(buffer));
+			strcpy(buffer, tempbuffer);
+			memset(tempbuffer, '\0', sizeof(tempbuffer));
+			ret = (strstr(buffer, "@@") != NULL);
 			while (!ret || (strstr(buffer, "@@") == NULL)) {
 				ret = select(establishedConnectionFD + 1, &readFDs, NULL, NULL, &idle);
+				if (ret == 0 || stopRequested) exit(1);	// idle timeout, or SIGTERM interrupted select(): drop the client
 				if (ret) {
-					charsRead = recv(establishedConnectionFD, tempbuffer, sizeof(tempbuffer), 0);
-					if (charsRead < 0) error ("ERROR reading from socket");
+					charsRead = recv(establishedConnectionFD, tempbuffer, sizeof(tempbuffer) - 1, 0);
+					if (charsRead < 0) error("ERROR reading from socket");
+					if (charsRead == 0) exit(1);	// client hung up before finishing the message
+					if (strlen(buffer) + charsRead >= sizeof(buffer)) rejectRequest(establishedConnectionFD, "message too long");
 					strcat(buffer, tempbuffer);
 					memset(tempbuffer, '\0', sizeof(tempbuffer));
 				}
-			} 
-			//printf("SERVER: I received this key from the client: %s\n", buffer); fflush(stdout);
-			memset(key, '\0', sizeof(key));
-			strcpy(key, buffer);
-			key[strcspn(key, "@@")] = '\0';			
+			}
+			unsigned char padDigest[PADCACHE_DIGEST_LEN];
+			char padHex[PADCACHE_HEX_LEN + 1];
+			size_t padLen = 0;
+			memset(pad, 0, sizeof(pad));
+			int cached = (sscanf(buffer, "pad %64s %zu", padHex, &padLen) == 2) &&
+					padcache_parsedigest(padHex, padDigest) &&
+					padcache_lookup(cache, padDigest, padLen, pad);
+			/* a pad shorter than the message would send the tail of it out unencrypted */
+			if (cached && padLen < strlen(ciphertext)) rejectRequest(establishedConnectionFD, "key too short for message");
+			memset(buffer, '\0', sizeof(buffer));
+			strcpy(buffer, cached ? "hit@@" : "miss@@");
+			send(establishedConnectionFD, buffer, strlen(buffer), 0);	// client only uploads the key on a miss
+
+			if (!cached) {
+				// Get the key from the client
+				charsRead = sizeof(buffer);
+				memset(buffer, '\0', sizeof(tempbuffer));
+				ret = 0;
+				while (!ret || (strstr(buffer, "@@") == NULL)) {
+					ret = select(establishedConnectionFD + 1, &readFDs, NULL, NULL, &idle);
+					if (ret == 0 || stopRequested) exit(1);	// idle timeout, or SIGTERM interrupted select(): drop the client
+					if (ret) {
+						charsRead = recv(establishedConnectionFD, tempbuffer, sizeof(tempbuffer) - 1, 0);
+						if (charsRead < 0) error ("ERROR reading from socket");
+						if (charsRead == 0) exit(1);	// client hung up before finishing the message
+						if (strlen(buffer) + charsRead >= sizeof(buffer)) rejectRequest(establishedConnectionFD, "message too long");
+						strcat(buffer, tempbuffer);
+						memset(tempbuffer, '\0', sizeof(tempbuffer));
+					}
+				} 
+				//printf("SERVER: I received this key from the client: %s\n", buffer); fflush(stdout);
+				memset(key, '\0', sizeof(key));
+				strcpy(key, buffer);
+				key[strcspn(key, "@@")] = '\0';			
+				/* decode once, and store under the hash of what was actually received */
+				padLen = strlen(key);
+				/* a bad key character would decode to index 0 and leave that character of the message in clear */
+				if (otpkernel_decode(key, padLen, pad) >= 0) rejectRequest(establishedConnectionFD, "bad character in key");
+				if (padLen < strlen(ciphertext)) rejectRequest(establishedConnectionFD, "key too short for message");
+				padcache_hash(key, padLen, padDigest);
+				padcache_insert(cache, padDigest, pad, padLen);
+			}
 
 			/* process data */
 			memset(plaintext, '\0', sizeof(plaintext));
-			int ciphertextletter, keyletter;
-			/* iterate through each char in ciphertext */
-			for (int i = 0; i < strlen(ciphertext); i++) {
-				/* check each char in charoptions */
-				for (int j = 0; j < strlen(charoptions); j++) {
-					/* set indices of key and ciphertext letter */
-					if (charoptions[j] == ciphertext[i]) {ciphertextletter = j;}
-					if (charoptions[j] == key[i]) {keyletter = j;}
-				}
-				if ((ciphertextletter - keyletter) < 0) { ciphertextletter += 27; }
-				/* decryption occurs here */
-				plaintext[i] = charoptions[(ciphertextletter - keyletter) % 27];
-				//printf("server %d, %d => %d => %d %c\n", ciphertextletter, keyletter, 
-					//(ciphertextletter - keyletter) % 27, plaintext[i], plaintext[i]); fflush(stdout);
-			}	
+			if (otpkernel_decrypt(ciphertext, pad, plaintext, strlen(ciphertext)) >= 0) rejectRequest(establishedConnectionFD, "bad character in message");
 			strcat(plaintext, "@@\0");
-			
-			sleep(1);		
-			
+
 			//printf("SERVER: Sending this decoded message to the client: %s\n", plaintext); fflush(stdout);		
 			// Send deciphered plaintext back to the client
 			charsRead = send(establishedConnectionFD, plaintext, sizeof(plaintext), 0); // Send success back
@@ -171,7 +244,11 @@ int main(int argc, char *argv[])
 			//printf("SERVER: done sending response\n"); fflush(stdout);
 		}
 		else {
-			wPid = waitpid(wPid, &stat, 0);
+			while (waitpid(wPid, &stat, 0) < 0) {
+				if (stopRequested) exit(0);	// SIGTERM interrupted waitpid()
+				if (errno != EINTR) error("ERROR waiting for request handler");
+			}
+			if (WIFSIGNALED(stat)) fprintf(stderr, "SERVER: request handler killed by signal %d\n", WTERMSIG(stat));
 			close(establishedConnectionFD);
 		} 
 	}
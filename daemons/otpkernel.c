@@ -0,0 +1,89 @@
+/***********************************************************************************************************
+ *	Title: One-Time-Pad Kernel
+ *	Date: 10/18/26
+ *	Description: Table driven encryption and decryption. Each table maps a (text byte, pad index) or
+ *			(text byte, key character) pair straight to the output byte, so the hot loop is one lookup
+ *			per character.
+ * ********************************************************************************************************/
+
+#include <string.h>
+#include "otpkernel.h"
+
+const char* otp_charoptions = " ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static signed char charIndex[256];		// byte -> index into charoptions, -1 if not allowed
+static char encTable[256][256];			// [text byte][pad index] -> output byte, 0 if either is not allowed
+static char decTable[256][256];
+static char encKeyTable[256][256];		// [text byte][key character] -> output byte, 0 if either is not allowed
+static char decKeyTable[256][256];
+static int ready = 0;
+
+void otpkernel_init(void) {
+	if (ready) return;
+	memset(charIndex, -1, sizeof(charIndex));
+	for (int j = 0; j < 27; j++) { charIndex[(unsigned char)otp_charoptions[j]] = j; }
+	memset(encTable, 0, sizeof(encTable));
+	memset(decTable, 0, sizeof(decTable));
+	memset(encKeyTable, 0, sizeof(encKeyTable));
+	memset(decKeyTable, 0, sizeof(decKeyTable));
+	for (int t = 0; t < 256; t++) {
+		for (int k = 0; k < 27; k++) {
+			if (t == '\n') { encTable[t][k] = decTable[t][k] = '\n'; }	// newlines pass through
+			else if (charIndex[t] >= 0) {
+				encTable[t][k] = otp_charoptions[(charIndex[t] + k) % 27];
+				decTable[t][k] = otp_charoptions[(charIndex[t] - k + 27) % 27];
+			}
+		}
+		for (int j = 0; j < 27; j++) {
+			unsigned char key = otp_charoptions[j];
+			encKeyTable[t][key] = encTable[t][j];
+			decKeyTable[t][key] = decTable[t][j];
+		}
+	}
+	ready = 1;
+}
+
+long otpkernel_decode(const char* text, size_t len, unsigned char* pad) {
+	long bad = -1;
+	otpkernel_init();
+	for (size_t i = 0; i < len; i++) {
+		signed char index = charIndex[(unsigned char)text[i]];
+		if (index < 0) { index = 0; if (bad < 0) bad = i; }
+		pad[i] = index;
+	}
+	return bad;
+}
+
+/* shared loop for all four directions. Bad characters look up 0, so the loop is one lookup per character
+ * with no branches, and the position of the first bad one is only searched for when there is one */
+static long apply(char table[256][256], const char* in, const unsigned char* pad, char* out, size_t len) {
+	otpkernel_init();
+	const unsigned char* text = (const unsigned char*)in;
+	unsigned char bad = 0;
+	for (size_t i = 0; i < len; i++) {
+		char c = table[text[i]][pad[i]];
+		out[i] = c;
+		bad |= (c == 0);
+	}
+	if (!bad) return -1;
+	for (size_t i = 0; i < len; i++) {
+		if (out[i] == 0) return i;
+	}
+	return -1;
+}
+
+long otpkernel_encrypt(const char* in, const unsigned char* pad, char* out, size_t len) {
+	return apply(encTable, in, pad, out, len);
+}
+
+long otpkernel_decrypt(const char* in, const unsigned char* pad, char* out, size_t len) {
+	return apply(decTable, in, pad, out, len);
+}
+
+long otpkernel_encryptkey(const char* in, const char* key, char* out, size_t len) {
+	return apply(encKeyTable, in, (const unsigned char*)key, out, len);
+}
+
+long otpkernel_decryptkey(const char* in, const char* key, char* out, size_t len) {
+	return apply(decKeyTable, in, (const unsigned char*)key, out, len);
+}
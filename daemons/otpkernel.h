@@ -0,0 +1,34 @@
+/***********************************************************************************************************
+ *	Title: One-Time-Pad Kernel
+ *	Date: 10/18/26
+ *	Description: The one-time-pad arithmetic shared by the daemons and otp_bulk. Text is mapped to indices
+ *			into charoptions (' ' is 0, 'A'..'Z' are 1..26) and combined with pad indices mod 27.
+ *			Newlines pass through unchanged so whole files can be transformed.
+ * ********************************************************************************************************/
+
+#ifndef OTPKERNEL_H
+#define OTPKERNEL_H
+
+#include <stddef.h>
+
+extern const char* otp_charoptions;
+
+/* build the lookup tables. Call once before any threads use the kernel */
+void otpkernel_init(void);
+
+/* convert text to charoptions indices. Bad characters become 0. Returns -1 if every character was
+ * allowed, otherwise the position of the first bad one. text and pad may be the same buffer */
+long otpkernel_decode(const char* text, size_t len, unsigned char* pad);
+
+/* encrypt or decrypt len characters of in with pad indices into out (in and out may be the same
+ * buffer). Returns -1 on success or the position of the first character outside charoptions, in which
+ * case the contents of out are undefined */
+long otpkernel_encrypt(const char* in, const unsigned char* pad, char* out, size_t len);
+long otpkernel_decrypt(const char* in, const unsigned char* pad, char* out, size_t len);
+
+/* the same with the pad given as key text, skipping otpkernel_decode. A key character outside
+ * charoptions is reported like a bad text character */
+long otpkernel_encryptkey(const char* in, const char* key, char* out, size_t len);
+long otpkernel_decryptkey(const char* in, const char* key, char* out, size_t len);
+
+#endif
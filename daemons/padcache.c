@@ -0,0 +1,203 @@
+/***********************************************************************************************************
+ *	Title: One-Time-Pad Key Cache
+ *	Date: 10/18/26
+ *	Description: Shared pad cache for the encryption and decryption daemons. The arena is mapped before
+ *			the daemon forks, so every child sees the same pads. Each process waits on the child it
+ *			forked before it accepts again, so only one process touches the arena at a time.
+ * ********************************************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "padcache.h"
+
+struct padcache_entry {
+	unsigned char digest[PADCACHE_DIGEST_LEN];
+	size_t len;
+	size_t offset;				// position of the pad in data[]
+	unsigned long lastUse;			// tick of the most recent lookup or insert
+};
+
+struct padcache {
+	size_t cap;				// bytes available in data[]
+	size_t used;				// bytes currently holding pads
+	unsigned long tick;
+	unsigned long hits, misses, evictions;
+	int count;
+	struct padcache_entry entries[PADCACHE_MAX_ENTRIES];	// kept in order of offset, packed from 0
+	unsigned char data[];
+};
+
+static const unsigned int sha256K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* run the SHA-256 compression function over one 64 byte block */
+static void sha256Block(unsigned int* state, const unsigned char* block) {
+	unsigned int w[64], a, b, c, d, e, f, g, h;
+	for (int i = 0; i < 16; i++) {
+		w[i] = (unsigned int)block[4 * i] << 24 | (unsigned int)block[4 * i + 1] << 16 |
+			(unsigned int)block[4 * i + 2] << 8 | block[4 * i + 3];
+	}
+	for (int i = 16; i < 64; i++) {
+		unsigned int s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		unsigned int s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	a = state[0]; b = state[1]; c = state[2]; d = state[3];
+	e = state[4]; f = state[5]; g = state[6]; h = state[7];
+	for (int i = 0; i < 64; i++) {
+		unsigned int t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+		unsigned int t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void padcache_hash(const char* text, size_t len, unsigned char* digest) {
+	unsigned int state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+				  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	unsigned char tail[128];
+	size_t full = len - len % 64;
+	for (size_t i = 0; i < full; i += 64) sha256Block(state, (const unsigned char*)text + i);
+
+	/* pad the remainder with 0x80, zeros and the message length in bits */
+	size_t rest = len - full, tailLen = (rest < 56) ? 64 : 128;
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, text + full, rest);
+	tail[rest] = 0x80;
+	unsigned long long bits = (unsigned long long)len * 8;
+	for (int i = 0; i < 8; i++) tail[tailLen - 1 - i] = (unsigned char)(bits >> (8 * i));
+	for (size_t i = 0; i < tailLen; i += 64) sha256Block(state, tail + i);
+
+	for (int i = 0; i < 8; i++) {
+		digest[4 * i] = state[i] >> 24; digest[4 * i + 1] = state[i] >> 16;
+		digest[4 * i + 2] = state[i] >> 8; digest[4 * i + 3] = state[i];
+	}
+}
+
+void padcache_hexdigest(const unsigned char* digest, char* hex) {
+	for (int i = 0; i < PADCACHE_DIGEST_LEN; i++) sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+int padcache_parsedigest(const char* hex, unsigned char* digest) {
+	for (int i = 0; i < PADCACHE_DIGEST_LEN; i++) {
+		unsigned int byte;
+		if (!isxdigit((unsigned char)hex[2 * i]) || !isxdigit((unsigned char)hex[2 * i + 1])) return 0;
+		sscanf(hex + 2 * i, "%2x", &byte);
+		digest[i] = byte;
+	}
+	return 1;
+}
+
+struct padcache* padcache_create(size_t capBytes) {
+	if (capBytes == 0) return NULL;
+	struct padcache* cache = mmap(NULL, sizeof(struct padcache) + capBytes, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (cache == MAP_FAILED) { perror("SERVER: pad cache disabled"); return NULL; }
+	memset(cache, '\0', sizeof(struct padcache));
+	cache->cap = capBytes;
+	return cache;
+}
+
+/* find the entry for a pad, or -1 if it is not held */
+static int padcache_find(struct padcache* cache, const unsigned char* digest, size_t len) {
+	for (int i = 0; i < cache->count; i++) {
+		if (cache->entries[i].len == len && !memcmp(cache->entries[i].digest, digest, PADCACHE_DIGEST_LEN)) return i;
+	}
+	return -1;
+}
+
+/* drop the least recently used pad and slide later pads down to keep data[] packed */
+static void padcache_evict(struct padcache* cache) {
+	int victim = 0;
+	for (int i = 1; i < cache->count; i++) {
+		if (cache->entries[i].lastUse < cache->entries[victim].lastUse) victim = i;
+	}
+	struct padcache_entry gone = cache->entries[victim];
+	memmove(cache->data + gone.offset, cache->data + gone.offset + gone.len, cache->used - gone.offset - gone.len);
+	for (int i = victim + 1; i < cache->count; i++) {
+		cache->entries[i].offset -= gone.len;
+		cache->entries[i - 1] = cache->entries[i];
+	}
+	cache->count--;
+	cache->used -= gone.len;
+	cache->evictions++;
+}
+
+int padcache_lookup(struct padcache* cache, const unsigned char* digest, size_t len, unsigned char* pad) {
+	if (cache == NULL) return 0;
+	int i = padcache_find(cache, digest, len);
+	if (i < 0) { cache->misses++; return 0; }
+	cache->entries[i].lastUse = ++cache->tick;
+	memcpy(pad, cache->data + cache->entries[i].offset, len);
+	cache->hits++;
+	return 1;
+}
+
+void padcache_insert(struct padcache* cache, const unsigned char* digest, const unsigned char* pad, size_t len) {
+	if (cache == NULL || len == 0 || len > cache->cap) return;
+	if (padcache_find(cache, digest, len) >= 0) return;		// another request already stored it
+	while (cache->count > 0 && (cache->used + len > cache->cap || cache->count == PADCACHE_MAX_ENTRIES)) {
+		padcache_evict(cache);
+	}
+	struct padcache_entry* entry = &cache->entries[cache->count++];
+	memcpy(entry->digest, digest, PADCACHE_DIGEST_LEN);
+	entry->len = len;
+	entry->offset = cache->used;
+	entry->lastUse = ++cache->tick;
+	memcpy(cache->data + entry->offset, pad, len);
+	cache->used += len;
+}
+
+/* helpers for padcache_report, which runs in the SIGUSR1 handler and so cannot use stdio */
+static size_t appendText(char* line, size_t n, const char* text) {
+	while (*text) line[n++] = *text++;
+	return n;
+}
+
+static size_t appendNumber(char* line, size_t n, unsigned long long value) {
+	char digits[20];
+	int count = 0;
+	do { digits[count++] = '0' + value % 10; value /= 10; } while (value > 0);
+	while (count > 0) line[n++] = digits[--count];
+	return n;
+}
+
+void padcache_report(struct padcache* cache, int fd) {
+	char line[256];
+	size_t n = 0;
+	if (cache == NULL) {
+		n = appendText(line, n, "SERVER: pad cache disabled\n");
+	} else {
+		n = appendText(line, n, "SERVER: pad cache hits ");
+		n = appendNumber(line, n, cache->hits);
+		n = appendText(line, n, " misses ");
+		n = appendNumber(line, n, cache->misses);
+		n = appendText(line, n, " evictions ");
+		n = appendNumber(line, n, cache->evictions);
+		n = appendText(line, n, " pads ");
+		n = appendNumber(line, n, cache->count);
+		n = appendText(line, n, " bytes ");
+		n = appendNumber(line, n, cache->used);
+		n = appendText(line, n, "/");
+		n = appendNumber(line, n, cache->cap);
+		n = appendText(line, n, "\n");
+	}
+	write(fd, line, n);
+}
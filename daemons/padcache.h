@@ -0,0 +1,43 @@
+/***********************************************************************************************************
+ *	Title: One-Time-Pad Key Cache
+ *	Date: 10/18/26
+ *	Description: Content-addressed cache of decoded key pads shared between the daemon and its forked
+ *			children. Pads are stored as 0..26 indices into charoptions so repeated keys skip both
+ *			the upload and the per-character parse. Pads are addressed by the SHA-256 digest of the
+ *			key text. Least recently used pads are evicted once the configured memory cap is reached.
+ * ********************************************************************************************************/
+
+#ifndef PADCACHE_H
+#define PADCACHE_H
+
+#include <stddef.h>
+
+#define PADCACHE_MAX_ENTRIES 256		// upper bound on the number of pads held at once
+#define PADCACHE_DEFAULT_KIB 4096		// memory cap used when none is given on the command line
+#define PADCACHE_DIGEST_LEN 32			// SHA-256 digest size in bytes
+#define PADCACHE_HEX_LEN (2 * PADCACHE_DIGEST_LEN)	// digest size as hex on the wire
+
+struct padcache;
+
+/* SHA-256 of key text, used by clients and daemons to address a pad */
+void padcache_hash(const char* text, size_t len, unsigned char* digest);
+
+/* write a digest as PADCACHE_HEX_LEN lowercase hex characters plus \0 */
+void padcache_hexdigest(const unsigned char* digest, char* hex);
+
+/* parse PADCACHE_HEX_LEN hex characters into a digest. Returns 1 on success, 0 on malformed input */
+int padcache_parsedigest(const char* hex, unsigned char* digest);
+
+/* map a shared arena of capBytes for pad data. Returns NULL if capBytes is 0 or mapping fails */
+struct padcache* padcache_create(size_t capBytes);
+
+/* copy a cached pad into pad. Returns 1 on a hit, 0 on a miss */
+int padcache_lookup(struct padcache* cache, const unsigned char* digest, size_t len, unsigned char* pad);
+
+/* store a decoded pad, evicting least recently used pads until it fits */
+void padcache_insert(struct padcache* cache, const unsigned char* digest, const unsigned char* pad, size_t len);
+
+/* write hit/miss/eviction counters and arena usage to fd. Async-signal-safe, for the SIGUSR1 handler */
+void padcache_report(struct padcache* cache, int fd);
+
+#endif
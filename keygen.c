@@ -21,10 +21,11 @@ int main(int argc, char** argv) {
 	if (argc > 1) {
 		/* parse argument from command line which specifies key length */
 		int bufferSize = atoi(argv[1]);
-		char* buffer = malloc(bufferSize * sizeof(char));
+		char* buffer = malloc((bufferSize + 1) * sizeof(char));
 		for (int i = 0; i < bufferSize; i++) {
 			buffer[i] = options[rand() % (strlen(options))];
 		}
+		buffer[bufferSize] = '\0';
 		/* output the key to stdout */
 		printf("%s\n", buffer);
 		free(buffer);
@@ -0,0 +1,313 @@
+/**********************************************************************************************************
+ *	Title: One-Time-Pad Bulk File Tool
+ *	Date: 10/18/26
+ *	Description: Offline encryption and decryption of whole files with a pad from keygen, without going
+ *			through the daemons. Runs a reader -> transform -> writer pipeline with one thread per
+ *			stage and bounded queues between them. The pad is consumed in order across the input
+ *			files, so decrypting needs the same pad and the same file order. Newlines pass through
+ *			unchanged but still use up a pad character. The transform stage runs on one worker per
+ *			spare CPU, so blocks can reach the writer out of order.
+ * *******************************************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "daemons/otpkernel.h"
+
+#define BLOCK_SIZE (1024 * 1024)	// bytes handed between stages at a time
+#define QUEUE_DEPTH 32			// slots per queue, an upper bound on the blocks in flight
+#define MAX_WORKERS 8			// transform threads at most
+
+void error(const char *msg) { perror(msg); exit(1); } // Error function used for reporting issues
+
+/* a slice of one input file and the matching slice of the pad */
+struct block {
+	int file;			// index into inputs, -1 marks the end of the stream
+	off_t offset;			// position of this slice in the input (and output) file
+	size_t len;
+	char* data;
+	char* pad;
+};
+
+/* bounded FIFO of blocks shared by two stages */
+struct queue {
+	struct block* slots[QUEUE_DEPTH];
+	int head, count;
+	pthread_mutex_t lock;
+	pthread_cond_t notEmpty, notFull;
+};
+
+/* time a stage spent working, as opposed to waiting on a queue */
+struct stage {
+	const char* name;
+	double busy;
+	unsigned long long bytes;
+};
+
+int decrypt = 0;
+int workers = 1;		// transform threads, from the CPUs left over after the reader and writer
+int padFD;
+off_t padLen;
+char** inputs;
+int inputCount;
+char* padPath;
+off_t* padBase;			// pad offset at which each input starts
+off_t* inputSize;		// input sizes from the layout pass. Exactly this many bytes are read
+char** outputs;			// outdir/<input basename> for each input
+struct queue freeQueue, readQueue, writeQueue;	// writer hands blocks back to the reader through freeQueue
+struct block endOfStream = { -1 };
+struct stage reader = { "reader" }, transform[MAX_WORKERS], writer = { "writer" };
+
+double now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void queueInit(struct queue* q) {
+	memset(q, 0, sizeof(*q));
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->notEmpty, NULL);
+	pthread_cond_init(&q->notFull, NULL);
+}
+
+void queuePush(struct queue* q, struct block* b) {
+	pthread_mutex_lock(&q->lock);
+	while (q->count == QUEUE_DEPTH) pthread_cond_wait(&q->notFull, &q->lock);
+	q->slots[(q->head + q->count) % QUEUE_DEPTH] = b;
+	q->count++;
+	pthread_cond_signal(&q->notEmpty);
+	pthread_mutex_unlock(&q->lock);
+}
+
+struct block* queuePop(struct queue* q) {
+	pthread_mutex_lock(&q->lock);
+	while (q->count == 0) pthread_cond_wait(&q->notEmpty, &q->lock);
+	struct block* b = q->slots[q->head];
+	q->head = (q->head + 1) % QUEUE_DEPTH;
+	q->count--;
+	pthread_cond_signal(&q->notFull);
+	pthread_mutex_unlock(&q->lock);
+	return b;
+}
+
+/* read exactly len bytes at offset, retrying short reads. A file that ends early is an error */
+void readFull(int fd, char* buf, size_t len, off_t offset, const char* path) {
+	while (len > 0) {
+		ssize_t n = pread(fd, buf, len, offset);
+		if (n < 0) error(path);
+		if (n == 0) { fprintf(stderr, "BULK: %s ended early (short read)\n", path); exit(1); }
+		buf += n; len -= n; offset += n;
+	}
+}
+
+/* stage 1: slice each input into blocks and attach the matching pad bytes */
+void* readStage(void* arg) {
+	for (int f = 0; f < inputCount; f++) {
+		int fd = open(inputs[f], O_RDONLY);
+		if (fd < 0) error(inputs[f]);
+		struct stat st;
+		fstat(fd, &st);
+		/* the pad layout assumed the earlier size. Reading more would reuse the next file's pad */
+		if (st.st_size != inputSize[f]) { fprintf(stderr, "BULK: %s changed size\n", inputs[f]); exit(1); }
+		off_t size = inputSize[f];
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);		// ask for aggressive readahead
+		posix_fadvise(padFD, padBase[f], size, POSIX_FADV_SEQUENTIAL);
+		off_t offset = 0;
+		do {
+			struct block* b = queuePop(&freeQueue);
+			double start = now();
+			b->file = f;
+			b->offset = offset;
+			b->len = (size - offset < BLOCK_SIZE) ? size - offset : BLOCK_SIZE;
+			readFull(fd, b->data, b->len, offset, inputs[f]);
+			readFull(padFD, b->pad, b->len, padBase[f] + offset, padPath);
+			offset += b->len;
+			reader.busy += now() - start;
+			reader.bytes += b->len;
+			queuePush(&readQueue, b);
+		} while (offset < size);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);		// input will not be read again
+		close(fd);
+	}
+	for (int i = 0; i < workers; i++) queuePush(&readQueue, &endOfStream);	// one for each worker
+	return NULL;
+}
+
+/* stage 2: run the shared kernel over the data in place, straight from the key text. Blocks are
+ * independent, so any number of these can share readQueue */
+void* transformStage(void* arg) {
+	struct stage* self = arg;
+	struct block* b;
+	while ((b = queuePop(&readQueue))->file >= 0) {
+		double start = now();
+		long bad = decrypt ? otpkernel_decryptkey(b->data, b->pad, b->data, b->len)
+				   : otpkernel_encryptkey(b->data, b->pad, b->data, b->len);
+		if (bad >= 0) {
+			unsigned char index;
+			if (otpkernel_decode(b->pad + bad, 1, &index) >= 0) {
+				fprintf(stderr, "BULK: bad key character for %s\n", inputs[b->file]);
+			} else {
+				fprintf(stderr, "BULK: bad input in %s\n", inputs[b->file]);
+			}
+			exit(1);
+		}
+		self->busy += now() - start;
+		self->bytes += b->len;
+		queuePush(&writeQueue, b);
+	}
+	queuePush(&writeQueue, b);
+	return NULL;
+}
+
+/* stage 3: write each block to its output file. Blocks of a file can arrive in any order, so a file is
+ * opened by whichever block comes first and closed once all of its bytes are written */
+void* writeStage(void* arg) {
+	int* fds = malloc(inputCount * sizeof(int));
+	off_t* written = calloc(inputCount, sizeof(off_t));
+	for (int f = 0; f < inputCount; f++) fds[f] = -1;
+	struct block* b;
+	for (int ended = 0; ended < workers; ) {
+		b = queuePop(&writeQueue);
+		if (b->file < 0) { ended++; continue; }
+		double start = now();
+		int f = b->file;
+		if (fds[f] < 0) {
+			fds[f] = open(outputs[f], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fds[f] < 0) error(outputs[f]);
+		}
+		for (size_t done = 0; done < b->len; ) {
+			ssize_t n = pwrite(fds[f], b->data + done, b->len - done, b->offset + done);
+			if (n < 0) error("BULK: ERROR writing output");
+			done += n;
+		}
+		written[f] += b->len;
+		if (written[f] == inputSize[f]) { close(fds[f]); fds[f] = -1; }
+		writer.busy += now() - start;
+		writer.bytes += b->len;
+		queuePush(&freeQueue, b);
+	}
+	free(fds);
+	free(written);
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 5 || (strcmp(argv[1], "enc") && strcmp(argv[1], "dec"))) {
+		fprintf(stderr, "USAGE: %s enc|dec keyfile outdir file...\n", argv[0]);
+		exit(1);
+	}
+	decrypt = !strcmp(argv[1], "dec");
+	padPath = argv[2];
+	char* outdir = argv[3];
+	inputs = argv + 4;
+	inputCount = argc - 4;
+
+	otpkernel_init();
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	workers = (cpus > 2) ? cpus - 2 : 1;
+	if (workers > MAX_WORKERS) workers = MAX_WORKERS;
+
+	/* the pad is one line from keygen. Its trailing newline is not part of the pad */
+	padFD = open(padPath, O_RDONLY);
+	if (padFD < 0) error(padPath);
+	struct stat st, padStat;
+	fstat(padFD, &st);
+	padStat = st;
+	padLen = st.st_size;
+	char tail;
+	if (padLen > 0 && pread(padFD, &tail, 1, padLen - 1) == 1 && tail == '\n') padLen--;
+
+	/* lay out where each file starts in the pad, and make sure the pad covers all of them */
+	padBase = malloc(inputCount * sizeof(off_t));
+	inputSize = malloc(inputCount * sizeof(off_t));
+	struct stat* inputStat = malloc(inputCount * sizeof(struct stat));
+	off_t needed = 0;
+	for (int f = 0; f < inputCount; f++) {
+		if (stat(inputs[f], &inputStat[f]) < 0) error(inputs[f]);
+		padBase[f] = needed;
+		inputSize[f] = inputStat[f].st_size;
+		needed += inputSize[f];
+	}
+	if (needed > padLen) {
+		fprintf(stderr, "BULK: key too short (%lld characters for %lld bytes of input)\n",
+			(long long)padLen, (long long)needed);
+		exit(1);
+	}
+
+	/* refuse outputs that would overwrite an input or the pad, or that two inputs would share */
+	outputs = malloc(inputCount * sizeof(char*));
+	for (int f = 0; f < inputCount; f++) {
+		char* name = strrchr(inputs[f], '/');
+		name = name ? name + 1 : inputs[f];
+		outputs[f] = malloc(strlen(outdir) + strlen(name) + 2);
+		sprintf(outputs[f], "%s/%s", outdir, name);
+		for (int g = 0; g < f; g++) {
+			if (!strcmp(outputs[f], outputs[g])) {
+				fprintf(stderr, "BULK: %s and %s would both be written to %s\n", inputs[g], inputs[f], outputs[f]);
+				exit(1);
+			}
+		}
+		if (stat(outputs[f], &st) < 0) continue;			// output does not exist yet
+		int clash = (st.st_dev == padStat.st_dev && st.st_ino == padStat.st_ino);
+		for (int g = 0; g < inputCount; g++) {
+			clash |= (st.st_dev == inputStat[g].st_dev && st.st_ino == inputStat[g].st_ino);
+		}
+		if (clash) {
+			fprintf(stderr, "BULK: output %s is one of the input files or the key\n", outputs[f]);
+			exit(1);
+		}
+	}
+	free(inputStat);
+
+	queueInit(&freeQueue);
+	queueInit(&readQueue);
+	queueInit(&writeQueue);
+	/* two blocks per worker keeps every worker busy while the reader and writer hold some */
+	int poolSize = 2 * workers + 6;
+	struct block* pool = calloc(poolSize, sizeof(struct block));
+	for (int i = 0; i < poolSize; i++) {
+		pool[i].data = malloc(BLOCK_SIZE);
+		pool[i].pad = malloc(BLOCK_SIZE);
+		if (pool[i].data == NULL || pool[i].pad == NULL) error("BULK: out of memory");
+		queuePush(&freeQueue, &pool[i]);
+	}
+	pthread_t threads[MAX_WORKERS + 2];
+	double start = now();
+	pthread_create(&threads[0], NULL, readStage, NULL);
+	pthread_create(&threads[1], NULL, writeStage, NULL);
+	for (int i = 0; i < workers; i++) {
+		transform[i].name = "transform";
+		pthread_create(&threads[i + 2], NULL, transformStage, &transform[i]);
+	}
+	for (int i = 0; i < workers + 2; i++) pthread_join(threads[i], NULL);
+	double elapsed = now() - start;
+
+	/* per-stage utilization: the busiest stage is the bottleneck. Transform is averaged over its workers */
+	struct stage transformAll = { "transform" };
+	for (int i = 0; i < workers; i++) transformAll.busy += transform[i].busy / workers;
+	struct stage* stages[] = { &reader, &transformAll, &writer };
+	fprintf(stderr, "BULK: %d files, %llu bytes in %.3f s (%.1f MB/s), %d transform worker(s)\n", inputCount,
+		writer.bytes, elapsed, elapsed > 0 ? writer.bytes / elapsed / 1e6 : 0.0, workers);
+	for (int i = 0; i < 3; i++) {
+		fprintf(stderr, "BULK: %-9s busy %.3f s (%5.1f%%)\n", stages[i]->name, stages[i]->busy,
+			elapsed > 0 ? 100.0 * stages[i]->busy / elapsed : 0.0);
+	}
+
+	for (int i = 0; i < poolSize; i++) { free(pool[i].data); free(pool[i].pad); }
+	free(pool);
+	for (int f = 0; f < inputCount; f++) free(outputs[f]);
+	free(outputs);
+	close(padFD);
+	free(padBase);
+	free(inputSize);
+	return 0;
+}
@@ -0,0 +1,114 @@
+/***********************************************************************************************************
+ *	Title: Pad Cache Test
+ *	Date: 10/18/26
+ *	Description: Drives padcache_insert/padcache_lookup directly to check LRU eviction order, that data[]
+ *			stays packed when a pad in the middle is evicted, the entry limit, and the counters
+ *			printed by padcache_report. Exits non-zero on the first failed check.
+ * ********************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../daemons/padcache.h"
+
+#define PAD 10		// bytes in each test pad
+
+int failures = 0;
+
+void check(int ok, const char* what) {
+	printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) failures++;
+}
+
+/* digest for a named test pad */
+void name(const char* label, unsigned char* digest) { padcache_hash(label, strlen(label), digest); }
+
+/* a pad whose bytes identify which pad it is */
+void fill(unsigned char* pad, int id) { for (int i = 0; i < PAD; i++) pad[i] = (id * 7 + i) % 27; }
+
+/* 1 if the cached pad for label is present and holds the bytes of pad id */
+int holds(struct padcache* cache, const char* label, int id) {
+	unsigned char digest[PADCACHE_DIGEST_LEN], want[PAD], got[PAD];
+	name(label, digest);
+	fill(want, id);
+	memset(got, 0xff, sizeof(got));
+	return padcache_lookup(cache, digest, PAD, got) && !memcmp(want, got, PAD);
+}
+
+void insert(struct padcache* cache, const char* label, int id) {
+	unsigned char digest[PADCACHE_DIGEST_LEN], pad[PAD];
+	name(label, digest);
+	fill(pad, id);
+	padcache_insert(cache, digest, pad, PAD);
+}
+
+/* capture padcache_report through a pipe */
+void report(struct padcache* cache, char* line, size_t size) {
+	int fds[2];
+	if (pipe(fds) < 0) { perror("pipe"); exit(1); }
+	padcache_report(cache, fds[1]);
+	close(fds[1]);
+	ssize_t n = read(fds[0], line, size - 1);
+	line[n > 0 ? n : 0] = '\0';
+	close(fds[0]);
+}
+
+int main() {
+	char line[256];
+
+	/* room for exactly three pads */
+	struct padcache* cache = padcache_create(3 * PAD);
+	check(cache != NULL, "cache created");
+	insert(cache, "A", 1);
+	insert(cache, "B", 2);
+	insert(cache, "C", 3);
+	check(holds(cache, "A", 1), "A cached");			// A is now the most recently used
+	insert(cache, "D", 4);						// full, so B (least recently used, in the middle) goes
+	check(!holds(cache, "B", 2), "least recently used B evicted");
+	check(holds(cache, "C", 3), "C intact after sliding down over B");
+	check(holds(cache, "D", 4), "D stored in the space freed at the end");
+	check(holds(cache, "A", 1), "A intact");
+	report(cache, line, sizeof(line));
+	check(!strcmp(line, "SERVER: pad cache hits 4 misses 1 evictions 1 pads 3 bytes 30/30\n"), "counters after eviction");
+
+	/* C is now least recently used, then D */
+	insert(cache, "E", 5);
+	check(!holds(cache, "C", 3), "C evicted next");
+	check(holds(cache, "E", 5) && holds(cache, "D", 4) && holds(cache, "A", 1), "remaining pads intact");
+
+	/* pads over the cap are not stored, and storing a pad twice keeps one copy */
+	unsigned char digest[PADCACHE_DIGEST_LEN], big[4 * PAD];
+	memset(big, 1, sizeof(big));
+	name("big", digest);
+	padcache_insert(cache, digest, big, sizeof(big));
+	check(!padcache_lookup(cache, digest, sizeof(big), big), "pad larger than the cap not stored");
+	insert(cache, "A", 1);
+	report(cache, line, sizeof(line));
+	check(strstr(line, "pads 3 bytes 30/30") != NULL, "duplicate insert keeps one copy");
+
+	/* a pad is only found under the length it was stored with */
+	unsigned char pad[PAD];
+	name("A", digest);
+	check(!padcache_lookup(cache, digest, PAD - 1, pad), "lookup with a different length misses");
+
+	/* entry limit: one pad past PADCACHE_MAX_ENTRIES evicts the oldest */
+	struct padcache* many = padcache_create(1024 * 1024);
+	char label[32];
+	for (int i = 0; i <= PADCACHE_MAX_ENTRIES; i++) {
+		sprintf(label, "pad%d", i);
+		insert(many, label, i);
+	}
+	check(!holds(many, "pad0", 0), "oldest pad evicted at the entry limit");
+	sprintf(label, "pad%d", PADCACHE_MAX_ENTRIES);
+	check(holds(many, "pad1", 1) && holds(many, label, PADCACHE_MAX_ENTRIES), "newer pads kept");
+	report(many, line, sizeof(line));
+	sprintf(label, "evictions 1 pads %d ", PADCACHE_MAX_ENTRIES);
+	check(strstr(line, label) != NULL, "entry count capped");
+
+	/* a cap of 0 disables the cache */
+	check(padcache_create(0) == NULL, "zero cap disables caching");
+
+	printf("%d failure(s)\n", failures);
+	return failures != 0;
+}